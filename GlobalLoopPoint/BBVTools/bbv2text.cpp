@@ -0,0 +1,77 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Converts a binary BBV file of the global profiler (-bb_binary) back to
+// the text format read by regions.py and the other PinPoints scripts.
+//
+// Usage: bbv2text [-slice N] <file.bbb> [<output.bb>]
+//   -slice N : print only the vector of slice N (0 based)
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include "bbv_reader.H"
+
+static void Usage()
+{
+    std::cerr << "Usage: bbv2text [-slice N] <file.bbb> [<output.bb>]"
+        << std::endl;
+    exit(1);
+}
+
+int main(int argc, char * argv[])
+{
+    long slice = -1;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-slice") == 0)
+    {
+        if (arg + 1 >= argc)
+            Usage();
+        slice = atol(argv[arg + 1]);
+        arg += 2;
+    }
+    if (arg >= argc || argc - arg > 2)
+        Usage();
+
+    BBV_READER reader;
+    if (!reader.Open(argv[arg]))
+    {
+        std::cerr << "bbv2text: " << reader.Error() << std::endl;
+        return 1;
+    }
+    if (!reader.Indexed())
+        std::cerr << "bbv2text: " << argv[arg]
+            << ": no slice index, the profile may be incomplete" << std::endl;
+
+    std::ofstream file;
+    if (argc - arg == 2)
+    {
+        file.open(argv[arg + 1]);
+        if (!file.is_open())
+        {
+            std::cerr << "bbv2text: cannot open " << argv[arg + 1]
+                << std::endl;
+            return 1;
+        }
+    }
+    std::ostream & out = file.is_open() ? file : std::cout;
+    // the profiler writes its text profiles with showbase
+    out.setf(std::ios::showbase);
+
+    BBV_RECORD record;
+    if (slice >= 0)
+    {
+        if (!reader.Slice(slice, record.entries))
+        {
+            std::cerr << "bbv2text: no slice " << slice << " (" <<
+                reader.SliceCount() << " slices)" << std::endl;
+            return 1;
+        }
+        record.type = BBV_RECORD_VECTOR;
+        BBV_READER::FormatText(record, out);
+        return 0;
+    }
+    while (reader.Next(record))
+        BBV_READER::FormatText(record, out);
+    return 0;
+}
@@ -0,0 +1,257 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: BSD-3-Clause
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bbv_reader.H"
+
+BBV_READER::BBV_READER()
+    : _fd(-1), _data(NULL), _size(0), _end(0), _next(BBV_HEADER_SIZE),
+      _tid(-1), _indexed(false)
+{
+}
+
+BBV_READER::~BBV_READER()
+{
+    Close();
+}
+
+bool BBV_READER::Open(const std::string & path)
+{
+    Close();
+    _fd = open(path.c_str(), O_RDONLY);
+    if (_fd < 0)
+    {
+        _error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(_fd, &st) != 0 || st.st_size < (off_t)BBV_HEADER_SIZE)
+    {
+        _error = path + ": not a BBV file";
+        Close();
+        return false;
+    }
+    _size = st.st_size;
+    void * map = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (map == MAP_FAILED)
+    {
+        _error = "cannot map " + path;
+        Close();
+        return false;
+    }
+    _data = static_cast<const uint8_t *>(map);
+
+    BBV_DECODER header(_data, _data + BBV_HEADER_SIZE);
+    if (memcmp(_data, BBV_FILE_MAGIC, sizeof(BBV_FILE_MAGIC)) != 0)
+    {
+        _error = path + ": not a BBV file";
+        Close();
+        return false;
+    }
+    header.Fixed(sizeof(BBV_FILE_MAGIC));
+    uint32_t version = header.Fixed(4);
+    if (version < 1 || version > BBV_FORMAT_VERSION)
+    {
+        _error = path + ": unsupported BBV format version";
+        Close();
+        return false;
+    }
+    _tid = static_cast<int32_t>(header.Fixed(4));
+    _indexed = ReadIndex();
+    if (!_indexed)
+        ScanIndex();
+    Rewind();
+    return true;
+}
+
+void BBV_READER::Close()
+{
+    if (_data)
+        munmap(const_cast<uint8_t *>(_data), _size);
+    if (_fd >= 0)
+        close(_fd);
+    _fd = -1;
+    _data = NULL;
+    _size = 0;
+    _end = 0;
+    _slices.clear();
+}
+
+bool BBV_READER::ReadIndex()
+{
+    if (_size < BBV_HEADER_SIZE + BBV_TRAILER_SIZE)
+        return false;
+    const uint8_t * trailer = _data + _size - BBV_TRAILER_SIZE;
+    if (memcmp(trailer + 16, BBV_INDEX_MAGIC, sizeof(BBV_INDEX_MAGIC)) != 0)
+        return false;
+    BBV_DECODER decoder(trailer, _data + _size);
+    uint64_t indexOffset = decoder.Fixed(8);
+    uint64_t count = decoder.Fixed(8);
+    if (indexOffset < BBV_HEADER_SIZE ||
+        indexOffset + count * 8 != _size - BBV_TRAILER_SIZE)
+        return false;
+
+    BBV_DECODER index(_data + indexOffset, trailer);
+    _slices.resize(count);
+    for (uint64_t i = 0; i < count; i++)
+        _slices[i] = index.Fixed(8);
+    _end = indexOffset;
+    return true;
+}
+
+// No trailer: the profiler did not close the file. Index the complete
+// records.
+void BBV_READER::ScanIndex()
+{
+    _end = _size;
+    _slices.clear();
+    BBV_RECORD record;
+    uint64_t offset = BBV_HEADER_SIZE;
+    while (offset < _end)
+    {
+        uint64_t next = Decode(offset, record);
+        if (!next)
+            break;
+        if (record.type == BBV_RECORD_VECTOR ||
+            record.type == BBV_RECORD_VECTOR_REF)
+            _slices.push_back(offset);
+        offset = next;
+    }
+    _end = offset;
+}
+
+bool BBV_READER::Slice(size_t n, std::vector<BBV_ENTRY> & entries) const
+{
+    entries.clear();
+    if (n >= _slices.size())
+        return false;
+    BBV_RECORD record;
+    if (!Decode(_slices[n], record))
+        return false;
+    // references always go to an earlier slice
+    while (record.type == BBV_RECORD_VECTOR_REF && record.ref < n)
+    {
+        n = record.ref;
+        if (!Decode(_slices[n], record))
+            return false;
+    }
+    if (record.type != BBV_RECORD_VECTOR)
+        return false;
+    entries.swap(record.entries);
+    return true;
+}
+
+bool BBV_READER::Next(BBV_RECORD & record)
+{
+    if (_next >= _end)
+        return false;
+    uint64_t next = Decode(_next, record);
+    if (!next)
+        return false;
+    _next = next;
+    return true;
+}
+
+uint64_t BBV_READER::Decode(uint64_t offset, BBV_RECORD & record) const
+{
+    BBV_DECODER head(_data + offset, _data + _end);
+    record.type = head.Byte();
+    record.offset = offset;
+    uint64_t size = head.Varint();
+    const uint8_t * payload = head.Position();
+    if (!head.Ok() || size > static_cast<uint64_t>(_data + _end - payload))
+        return 0;
+
+    BBV_DECODER decoder(payload, payload + size);
+    switch (record.type)
+    {
+      case BBV_RECORD_TEXT:
+        record.text.assign(reinterpret_cast<const char *>(payload), size);
+        break;
+      case BBV_RECORD_IMAGE:
+        record.image.name = decoder.String();
+        record.image.low = decoder.Varint();
+        record.image.loadOffset = decoder.Varint();
+        break;
+      case BBV_RECORD_MARKER:
+        record.marker = BBV_MARKER();
+        record.marker.kind = decoder.Byte();
+        record.marker.address = decoder.Varint();
+        record.marker.count = static_cast<int64_t>(decoder.Varint());
+        if (record.marker.kind == BBV_MARKER_M ||
+            record.marker.kind == BBV_MARKER_GM)
+        {
+            record.marker.noImage = decoder.Byte() != 0;
+        }
+        else
+        {
+            record.marker.image = decoder.String();
+            record.marker.low = decoder.Varint();
+            record.marker.offset = decoder.Varint();
+            record.marker.file = decoder.String();
+            record.marker.line = static_cast<int32_t>(decoder.Varint());
+        }
+        break;
+      case BBV_RECORD_VECTOR:
+        if (!DecodeEntries(decoder, record.entries))
+            return 0;
+        break;
+      case BBV_RECORD_VECTOR_REF:
+        record.ref = decoder.Varint();
+        break;
+      default:
+        // unknown record types are skipped
+        break;
+    }
+    if (!decoder.Ok())
+        return 0;
+    return (payload - _data) + size;
+}
+
+bool BBV_READER::DecodeEntries(BBV_DECODER & decoder,
+    std::vector<BBV_ENTRY> & entries) const
+{
+    uint64_t n = decoder.Varint();
+    entries.clear();
+    entries.reserve(n);
+    int64_t id = 0;
+    for (uint64_t i = 0; i < n && decoder.Ok(); i++)
+    {
+        BBV_ENTRY entry;
+        id += decoder.Zigzag();
+        entry.id = static_cast<uint32_t>(id);
+        entry.count = static_cast<int64_t>(decoder.Varint());
+        entries.push_back(entry);
+    }
+    return decoder.Ok();
+}
+
+void BBV_READER::FormatText(const BBV_RECORD & record, std::ostream & out)
+{
+    switch (record.type)
+    {
+      case BBV_RECORD_TEXT:
+        out << record.text << std::endl;
+        break;
+      case BBV_RECORD_IMAGE:
+        BbvFormatImage(out, record.image);
+        break;
+      case BBV_RECORD_MARKER:
+        BbvFormatMarker(out, record.marker);
+        break;
+      case BBV_RECORD_VECTOR:
+        out << "T";
+        for (std::vector<BBV_ENTRY>::const_iterator it =
+            record.entries.begin(); it != record.entries.end(); it++)
+            BbvFormatEntry(out, it->id, it->count);
+        out << std::endl;
+        break;
+      case BBV_RECORD_VECTOR_REF:
+        BbvFormatVectorRef(out, record.ref);
+        break;
+      default:
+        break;
+    }
+}
@@ -0,0 +1,165 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Splits a profile container of the global profiler (-bb_container) into
+// the .bb files the profiler writes without it: <basename>.global.bb and
+// <basename>.T.<tid>.bb. See ../Profiler/DCFG/bbv_container.H.
+//
+// Usage: bbvdemux [-list] <file.bbc[.gz]> [<basename>]
+//   -list      : print the streams, their slices and sizes instead
+//   <basename> : default: the container name without .global[.pid].bbc[.gz]
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "bbv_format.H"
+#include "bbv_container.H"
+
+struct STREAM {
+    STREAM() : file(NULL), chunks(0), slices(0), bytes(0) {}
+    std::ofstream * file;
+    uint64_t chunks;
+    uint32_t slices;
+    uint64_t bytes;
+};
+
+static void Usage()
+{
+    std::cerr << "Usage: bbvdemux [-list] <file.bbc[.gz]> [<basename>]"
+        << std::endl;
+    exit(1);
+}
+
+static bool EndsWith(const std::string & s, const std::string & suffix)
+{
+    return s.size() >= suffix.size() &&
+        s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static uint32_t GetFixed32(const unsigned char * p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// gzread() reads plain files as they are, so this also handles containers
+// written without -bb_compress.
+static bool Read(gzFile in, void * buf, uint32_t size)
+{
+    return gzread(in, buf, size) == static_cast<int>(size);
+}
+
+int main(int argc, char * argv[])
+{
+    bool list = false;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-list") == 0)
+    {
+        list = true;
+        arg++;
+    }
+    if (arg >= argc || argc - arg > 2)
+        Usage();
+
+    std::string name = argv[arg];
+    gzFile in = gzopen(name.c_str(), "rb");
+    if (!in)
+    {
+        std::cerr << "bbvdemux: cannot open " << name << std::endl;
+        return 1;
+    }
+    unsigned char header[BBV_CONTAINER_HEADER_SIZE];
+    if (!Read(in, header, sizeof(header)) ||
+        memcmp(header, BBV_CONTAINER_MAGIC, sizeof(BBV_CONTAINER_MAGIC)) != 0)
+    {
+        std::cerr << "bbvdemux: " << name << ": not a profile container"
+            << std::endl;
+        return 1;
+    }
+    if (GetFixed32(header + 8) != BBV_CONTAINER_VERSION)
+    {
+        std::cerr << "bbvdemux: " << name
+            << ": unsupported container version" << std::endl;
+        return 1;
+    }
+    uint32_t pid = GetFixed32(header + 12);
+
+    std::string basename;
+    if (argc - arg == 2)
+    {
+        basename = argv[arg + 1];
+    }
+    else
+    {
+        basename = name;
+        if (EndsWith(basename, ".gz"))
+            basename.resize(basename.size() - 3);
+        if (EndsWith(basename, ".bbc"))
+            basename.resize(basename.size() - 4);
+        std::string global = BbvStreamSuffix(BBV_CONTAINER_GLOBAL, pid);
+        if (EndsWith(basename, global))
+            basename.resize(basename.size() - global.size());
+    }
+
+    std::map<uint32_t, STREAM> streams;
+    std::vector<char> data;
+    bool complete = true;
+    unsigned char head[BBV_CONTAINER_CHUNK_HEAD_SIZE];
+    int got;
+    while ((got = gzread(in, head, sizeof(head))) > 0)
+    {
+        if (got != sizeof(head))
+        {
+            complete = false;
+            break;
+        }
+        uint32_t size = GetFixed32(head + 8);
+        data.resize(size);
+        if (!Read(in, data.data(), size))
+        {
+            complete = false;
+            break;
+        }
+        uint32_t id = GetFixed32(head);
+        STREAM & stream = streams[id];
+        stream.chunks++;
+        stream.bytes += size;
+        if (GetFixed32(head + 4) + 1 > stream.slices)
+            stream.slices = GetFixed32(head + 4) + 1;
+        if (list)
+            continue;
+        if (!stream.file)
+        {
+            std::string out = basename + BbvStreamSuffix(id, pid) + ".bb";
+            stream.file = new std::ofstream(out.c_str(), std::ios::binary);
+            if (!stream.file->is_open())
+            {
+                std::cerr << "bbvdemux: cannot open " << out << std::endl;
+                return 1;
+            }
+        }
+        stream.file->write(data.data(), size);
+    }
+    if (got < 0)
+        complete = false;
+    gzclose(in);
+    if (!complete)
+        std::cerr << "bbvdemux: " << name
+            << ": truncated chunk, the profile may be incomplete" << std::endl;
+
+    for (std::map<uint32_t, STREAM>::iterator it = streams.begin();
+        it != streams.end(); it++)
+    {
+        if (list)
+        {
+            std::cout << basename << BbvStreamSuffix(it->first, pid) << ".bb"
+                << " chunks: " << it->second.chunks
+                << " slices: " << it->second.slices
+                << " bytes: " << it->second.bytes << std::endl;
+        }
+        delete it->second.file;
+    }
+    return 0;
+}
@@ -0,0 +1,530 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Merges text profiles of the global profiler (.global.bb, .T.<tid>.bb,
+// also gzip-compressed) from separate runs, inputs or pinball segments
+// into one profile with one block id space. Blocks are matched through
+// the "Block id:" records at the end of every profile: by their stable
+// key when all the profiles have one (-bb_stable_ids), by start:end and
+// size otherwise. The merged profile has the slices of every input in
+// order, tagged with "I: <input>", followed by one program end trailer
+// with the instruction counts summed and one "Block id:" record per merged
+// block with the counts summed.
+//
+// Usage: bbvmerge [-j N] -o <merged.bb> <file.bb[.gz]>...
+//   -j N : number of input files processed at the same time (default 4)
+//
+// Memory is bounded by the block tables; the vectors are streamed, each
+// input to <merged.bb>.part.<n> and then into the merged profile.
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BLOCK {
+    BLOCK() : id(0), start(0), end(0), instructions(0), count(0), size(0),
+        key(0), hasKey(false) {}
+    uint32_t id;
+    uint64_t start;
+    uint64_t end;
+    uint64_t instructions;
+    int64_t count;
+    uint64_t size;
+    uint64_t key;
+    bool hasKey;
+};
+
+// Merge key of a block: the stable key, or start, end and size.
+struct KEY {
+    uint64_t a, b, c;
+    bool operator<(const KEY & other) const
+    {
+        if (a != other.a) return a < other.a;
+        if (b != other.b) return b < other.b;
+        return c < other.c;
+    }
+};
+
+struct INPUT {
+    INPUT() : slices(0), instructions(0), unfiltered(0), sliceSize(0),
+        lease(0), ok(true) {}
+    std::string name;
+    std::vector<BLOCK> blocks;
+    std::vector<std::string> images;    // "Image key:" records
+    std::vector<uint32_t> merged;       // input block id -> merged id
+    uint64_t slices;
+    // program end trailer
+    uint64_t instructions;
+    uint64_t unfiltered;
+    uint64_t sliceSize;
+    uint64_t lease;
+    std::string filterKnobs;
+    bool ok;
+    std::string error;
+};
+
+static void Usage()
+{
+    std::cerr << "Usage: bbvmerge [-j N] -o <merged.bb> <file.bb[.gz]>..."
+        << std::endl;
+    exit(1);
+}
+
+static bool StartsWith(const std::string & s, const char * prefix)
+{
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// One line without its newline; false at the end of the file.
+static bool ReadLine(gzFile in, std::string & line)
+{
+    char buf[65536];
+    line.clear();
+    while (gzgets(in, buf, sizeof(buf)))
+    {
+        size_t n = strlen(buf);
+        if (n && buf[n - 1] == '\n')
+        {
+            line.append(buf, n - 1);
+            return true;
+        }
+        line.append(buf, n);
+    }
+    return !line.empty();
+}
+
+static std::vector<std::string> Split(const std::string & line)
+{
+    std::vector<std::string> tokens;
+    size_t at = 0;
+    while (true)
+    {
+        at = line.find_first_not_of(" \t", at);
+        if (at == std::string::npos)
+            break;
+        size_t end = line.find_first_of(" \t", at);
+        tokens.push_back(line.substr(at, end - at));
+        at = end;
+    }
+    return tokens;
+}
+
+// The token after 'label' in 'tokens', or "" if there is none.
+static std::string After(const std::vector<std::string> & tokens,
+    const char * label)
+{
+    for (size_t i = 0; i + 1 < tokens.size(); i++)
+    {
+        if (tokens[i] == label)
+            return tokens[i + 1];
+    }
+    return "";
+}
+
+// "Block id: 12 0x401000:0x401010 static instructions: 4 block count: 9
+//  block size: 18 [stable key: 0x...] [previous-block counts: (...)]"
+static bool ParseBlock(const std::string & line, BLOCK & block)
+{
+    std::vector<std::string> tokens = Split(line);
+    if (tokens.size() < 4)
+        return false;
+    block.id = strtoul(tokens[2].c_str(), NULL, 10);
+    size_t colon = tokens[3].find(':');
+    if (colon == std::string::npos)
+        return false;
+    block.start = strtoull(tokens[3].c_str(), NULL, 0);
+    block.end = strtoull(tokens[3].c_str() + colon + 1, NULL, 0);
+    block.instructions = strtoull(After(tokens, "instructions:").c_str(),
+        NULL, 10);
+    block.count = strtoll(After(tokens, "count:").c_str(), NULL, 10);
+    block.size = strtoull(After(tokens, "size:").c_str(), NULL, 10);
+    std::string key = After(tokens, "key:");
+    block.hasKey = !key.empty();
+    block.key = strtoull(key.c_str(), NULL, 0);
+    return block.id != 0;
+}
+
+// The records of the program end trailer, written once for the merged
+// profile instead of once per input.
+static bool IsTrailer(const std::string & line)
+{
+    return StartsWith(line, "Dynamic instruction count ") ||
+        StartsWith(line, "Dynamic unfiltered instruction count ") ||
+        StartsWith(line, "# Filter knobs: ") ||
+        StartsWith(line, "SliceSize: ") ||
+        StartsWith(line, "# Slice credit lease: ") ||
+        StartsWith(line, "End of bb");
+}
+
+static uint64_t NumberAfter(const std::string & line, const char * prefix)
+{
+    return strtoull(line.c_str() + strlen(prefix), NULL, 10);
+}
+
+// Pass 1: the block records, the number of slices and the trailer.
+static void ReadBlocks(INPUT & input)
+{
+    gzFile in = gzopen(input.name.c_str(), "rb");
+    if (!in)
+    {
+        input.ok = false;
+        input.error = "cannot open " + input.name;
+        return;
+    }
+    std::string line;
+    while (ReadLine(in, line))
+    {
+        if (StartsWith(line, "T"))
+        {
+            input.slices++;
+        }
+        else if (StartsWith(line, "Block id:"))
+        {
+            BLOCK block;
+            if (!ParseBlock(line, block))
+            {
+                input.ok = false;
+                input.error = input.name + ": bad record: " + line;
+                break;
+            }
+            input.blocks.push_back(block);
+        }
+        else if (StartsWith(line, "Image key:"))
+        {
+            input.images.push_back(line);
+        }
+        else if (StartsWith(line, "Dynamic instruction count "))
+        {
+            input.instructions =
+                NumberAfter(line, "Dynamic instruction count ");
+        }
+        else if (StartsWith(line, "Dynamic unfiltered instruction count "))
+        {
+            input.unfiltered =
+                NumberAfter(line, "Dynamic unfiltered instruction count ");
+        }
+        else if (StartsWith(line, "# Filter knobs: "))
+        {
+            input.filterKnobs = line.substr(strlen("# Filter knobs: "));
+        }
+        else if (StartsWith(line, "SliceSize: "))
+        {
+            input.sliceSize = NumberAfter(line, "SliceSize: ");
+        }
+        else if (StartsWith(line, "# Slice credit lease: "))
+        {
+            input.lease = NumberAfter(line, "# Slice credit lease: ");
+        }
+    }
+    gzclose(in);
+}
+
+// Pass 2: the slices of 'input' with the merged block ids, to 'part'.
+// "T=<n>" back-references (-bb_dedup) are moved by the slices of the
+// inputs before it ('base').
+static void WritePart(INPUT & input, uint32_t number, uint64_t base,
+    const std::string & part)
+{
+    gzFile in = gzopen(input.name.c_str(), "rb");
+    FILE * out = fopen(part.c_str(), "w");
+    if (!in || !out)
+    {
+        input.ok = false;
+        input.error = "cannot open " + (in ? part : input.name);
+        if (in) gzclose(in);
+        if (out) fclose(out);
+        return;
+    }
+    fprintf(out, "# Input %u: %s\n", number, input.name.c_str());
+    std::string line;
+    while (ReadLine(in, line) && input.ok)
+    {
+        if (StartsWith(line, "Block id:") || StartsWith(line, "Image key:") ||
+            IsTrailer(line))
+            continue;
+        if (StartsWith(line, "I: "))
+        {
+            fprintf(out, "I: %u\n", number);
+        }
+        else if (StartsWith(line, "T="))
+        {
+            fprintf(out, "T=%llu\n",
+                (unsigned long long)(base + strtoull(line.c_str() + 2, NULL,
+                    10)));
+        }
+        else if (StartsWith(line, "T"))
+        {
+            fputc('T', out);
+            const char * p = line.c_str() + 1;
+            while ((p = strchr(p, ':')))
+            {
+                char * next;
+                unsigned long id = strtoul(p + 1, &next, 10);
+                char * end = next;
+                long long count = 0;
+                if (next > p + 1 && *next == ':')
+                    count = strtoll(next + 1, &end, 10);
+                // no id, no ':' or no count
+                if (end <= next + 1)
+                {
+                    input.ok = false;
+                    input.error = input.name + ": malformed vector entry \"" +
+                        std::string(p, strcspn(p, " ")) + "\"";
+                    break;
+                }
+                if (id >= input.merged.size() || !input.merged[id])
+                {
+                    input.ok = false;
+                    input.error = input.name + ": block id " +
+                        std::to_string(id) + " has no \"Block id:\" record";
+                    break;
+                }
+                fprintf(out, ":%u:%lld ", input.merged[id], count);
+                p = end;
+            }
+            fputc('\n', out);
+        }
+        else
+        {
+            fprintf(out, "%s\n", line.c_str());
+        }
+    }
+    gzclose(in);
+    if (fclose(out) != 0 && input.ok)
+    {
+        input.ok = false;
+        input.error = part + ": " + strerror(errno);
+    }
+}
+
+// Runs 'work' for every input on 'jobs' threads.
+template <typename WORK>
+static void ForEachInput(std::vector<INPUT> & inputs, unsigned jobs,
+    WORK work)
+{
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned j = 0; j < jobs && j < inputs.size(); j++)
+    {
+        threads.push_back(std::thread([&]() {
+            size_t i;
+            while ((i = next++) < inputs.size())
+                work(i);
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+}
+
+static bool CheckInputs(const std::vector<INPUT> & inputs)
+{
+    bool ok = true;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        if (!inputs[i].ok)
+        {
+            std::cerr << "bbvmerge: " << inputs[i].error << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned jobs = 4;
+    std::string output;
+    std::vector<INPUT> inputs;
+    for (int arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "-j") == 0 && arg + 1 < argc)
+        {
+            jobs = atoi(argv[++arg]);
+        }
+        else if (strcmp(argv[arg], "-o") == 0 && arg + 1 < argc)
+        {
+            output = argv[++arg];
+        }
+        else if (argv[arg][0] == '-')
+        {
+            Usage();
+        }
+        else
+        {
+            inputs.push_back(INPUT());
+            inputs.back().name = argv[arg];
+        }
+    }
+    if (output.empty() || inputs.empty() || jobs == 0)
+        Usage();
+
+    ForEachInput(inputs, jobs, [&](size_t i) { ReadBlocks(inputs[i]); });
+    if (!CheckInputs(inputs))
+        return 1;
+
+    // Stable keys only if every block has one, otherwise the addresses.
+    bool stable = true;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        for (size_t b = 0; b < inputs[i].blocks.size(); b++)
+            stable = stable && inputs[i].blocks[b].hasKey;
+    }
+    if (!stable)
+        std::cerr << "bbvmerge: not all the profiles have stable keys"
+            << " (-bb_stable_ids), matching blocks by address" << std::endl;
+
+    // Merged ids in the order of the inputs and of their block records.
+    std::map<KEY, uint32_t> ids;
+    std::vector<BLOCK> merged(1);
+    std::vector<uint64_t> bases;
+    uint64_t slices = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        INPUT & input = inputs[i];
+        bases.push_back(slices);
+        slices += input.slices;
+        for (size_t b = 0; b < input.blocks.size(); b++)
+        {
+            const BLOCK & block = input.blocks[b];
+            KEY key = {block.key, 0, 0};
+            if (!stable)
+            {
+                key.a = block.start;
+                key.b = block.end;
+                key.c = block.size;
+            }
+            std::map<KEY, uint32_t>::iterator it = ids.find(key);
+            uint32_t id;
+            if (it == ids.end())
+            {
+                id = merged.size();
+                ids[key] = id;
+                merged.push_back(block);
+                merged.back().id = id;
+                merged.back().count = 0;
+            }
+            else
+            {
+                id = it->second;
+            }
+            merged[id].count += block.count;
+            if (block.id >= input.merged.size())
+                input.merged.resize(block.id + 1, 0);
+            input.merged[block.id] = id;
+        }
+    }
+
+    ForEachInput(inputs, jobs, [&](size_t i) {
+        WritePart(inputs[i], i, bases[i],
+            output + ".part." + std::to_string(i));
+    });
+    bool ok = CheckInputs(inputs);
+
+    FILE * out = ok ? fopen(output.c_str(), "w") : NULL;
+    if (ok && !out)
+    {
+        std::cerr << "bbvmerge: cannot open " << output << std::endl;
+        ok = false;
+    }
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        std::string part = output + ".part." + std::to_string(i);
+        FILE * in = ok ? fopen(part.c_str(), "r") : NULL;
+        if (in)
+        {
+            char buf[65536];
+            size_t n;
+            while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+                fwrite(buf, 1, n, out);
+            fclose(in);
+        }
+        remove(part.c_str());
+    }
+    if (!ok)
+        return 1;
+
+    // One trailer for all the inputs. The slice size and the filter knobs
+    // are those of the first input that has them.
+    uint64_t instructions = 0;
+    uint64_t unfiltered = 0;
+    uint64_t sliceSize = 0;
+    uint64_t lease = 0;
+    std::string filterKnobs;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        const INPUT & input = inputs[i];
+        instructions += input.instructions;
+        unfiltered += input.unfiltered;
+        if (input.lease > lease)
+            lease = input.lease;
+        if (filterKnobs.empty())
+            filterKnobs = input.filterKnobs;
+        if (!input.sliceSize)
+            continue;
+        if (!sliceSize)
+            sliceSize = input.sliceSize;
+        else if (input.sliceSize != sliceSize)
+            std::cerr << "bbvmerge: " << input.name << ": slice size "
+                << input.sliceSize << " differs from " << sliceSize
+                << std::endl;
+    }
+    fprintf(out, "Dynamic instruction count %llu\n",
+        (unsigned long long)instructions);
+    fprintf(out, "Dynamic unfiltered instruction count %llu\n",
+        (unsigned long long)unfiltered);
+    if (!filterKnobs.empty())
+        fprintf(out, "# Filter knobs: %s\n", filterKnobs.c_str());
+    if (sliceSize)
+        fprintf(out, "SliceSize: %llu\n", (unsigned long long)sliceSize);
+    if (lease)
+        fprintf(out, "# Slice credit lease: %llu (maximum boundary error"
+            " per thread)\n", (unsigned long long)lease);
+
+    std::map<std::string, bool> images;
+    uint32_t image = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        for (size_t m = 0; m < inputs[i].images.size(); m++)
+        {
+            // "Image key: <id> <key> build-id: <id> <name>"
+            std::vector<std::string> tokens = Split(inputs[i].images[m]);
+            if (tokens.size() < 7 || images[tokens[3]])
+                continue;
+            images[tokens[3]] = true;
+            fprintf(out, "Image key: %u %s", image++, tokens[3].c_str());
+            for (size_t t = 4; t < tokens.size(); t++)
+                fprintf(out, " %s", tokens[t].c_str());
+            fprintf(out, "\n");
+        }
+    }
+    for (size_t id = 1; id < merged.size(); id++)
+    {
+        const BLOCK & block = merged[id];
+        fprintf(out, "Block id: %u %#llx:%#llx static instructions: %llu"
+            " block count: %lld block size: %llu", block.id,
+            (unsigned long long)block.start, (unsigned long long)block.end,
+            (unsigned long long)block.instructions, (long long)block.count,
+            (unsigned long long)block.size);
+        if (stable)
+            fprintf(out, " stable key: %#llx", (unsigned long long)block.key);
+        fprintf(out, "\n");
+    }
+    fprintf(out, "End of bb\n");
+    if (fclose(out) != 0)
+    {
+        std::cerr << "bbvmerge: " << output << ": " << strerror(errno)
+            << std::endl;
+        return 1;
+    }
+    std::cerr << "bbvmerge: " << inputs.size() << " inputs, " << slices
+        << " slices, " << merged.size() - 1 << " blocks" << std::endl;
+    return 0;
+}
@@ -0,0 +1,212 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: BSD-3-Clause
+//
+// Helper of "make check": writes a text profile the way the global
+// profiler does with -bb_binary or -bb_container, so that bbv2text and
+// bbvdemux can be checked to give the text profile back.
+//
+// Usage: bbvcheck bbb <in.bb> <tid> <out.bbb>
+//          the records of <in.bb> through BBV_WRITER
+//        bbvcheck bbc <out.bbc> <stream>=<in.bb>...
+//          the profiles as the chunks of one container, one chunk per
+//          slice and stream in turn; <stream> is "global" or a thread id
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bbv_format.H"
+#include "bbv_container.H"
+
+static void Usage()
+{
+    std::cerr << "Usage: bbvcheck bbb <in.bb> <tid> <out.bbb>" << std::endl
+        << "       bbvcheck bbc <out.bbc> <stream>=<in.bb>..." << std::endl;
+    exit(1);
+}
+
+static bool StartsWith(const std::string & s, const char * prefix)
+{
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// "S: 0x401000 1 /tmp/app 0x400000 + 0x1000 # app.c:10", "M: 0x401000 3"
+// or "M: 0x401000 3 no_image 0", see BbvFormatMarker().
+static bool ParseMarker(const std::string & line, BBV_MARKER & m)
+{
+    std::istringstream in(line);
+    std::string kind, plus, hash, location;
+    in >> kind;
+    if (kind == "S:") m.kind = BBV_MARKER_S;
+    else if (kind == "M:") m.kind = BBV_MARKER_M;
+    else if (kind == "GS:") m.kind = BBV_MARKER_GS;
+    else if (kind == "GM:") m.kind = BBV_MARKER_GM;
+    else return false;
+    in >> std::hex >> m.address >> std::dec >> m.count;
+    if (m.kind == BBV_MARKER_M || m.kind == BBV_MARKER_GM)
+    {
+        std::string noImage;
+        m.noImage = (in >> noImage) && noImage == "no_image";
+        return !in.bad();
+    }
+    in >> m.image >> std::hex >> m.low >> plus >> m.offset >> hash
+        >> location;
+    size_t colon = location.rfind(':');
+    if (!in || colon == std::string::npos)
+        return false;
+    m.line = atoi(location.c_str() + colon + 1);
+    if (m.line)
+        m.file = location.substr(0, colon);
+    return true;
+}
+
+// "G: /tmp/app LowAddress: 0x400000 LoadOffset: 0", see BbvFormatImage().
+static bool ParseImage(const std::string & line, BBV_IMAGE & img)
+{
+    std::istringstream in(line);
+    std::string g, lowLabel, offsetLabel;
+    in >> g >> img.name >> lowLabel >> std::hex >> img.low >> offsetLabel
+        >> img.loadOffset;
+    return !in.fail();
+}
+
+static int WriteBinary(const char * name, int32_t tid, const char * out)
+{
+    std::ifstream in(name);
+    if (!in.is_open())
+    {
+        std::cerr << "bbvcheck: cannot open " << name << std::endl;
+        return 1;
+    }
+    BBV_WRITER writer;
+    if (!writer.Open(out, tid))
+    {
+        std::cerr << "bbvcheck: cannot open " << out << std::endl;
+        return 1;
+    }
+    std::string line;
+    while (std::getline(in, line))
+    {
+        BBV_MARKER marker;
+        BBV_IMAGE img;
+        if (StartsWith(line, "T="))
+        {
+            writer.VectorRef(strtoull(line.c_str() + 2, NULL, 10));
+        }
+        else if (StartsWith(line, "T"))
+        {
+            writer.BeginVector();
+            const char * p = line.c_str() + 1;
+            while ((p = strchr(p, ':')))
+            {
+                char * next;
+                uint32_t id = strtoul(p + 1, &next, 10);
+                int64_t count = strtoll(next + 1, &next, 10);
+                writer.Entry(id, count);
+                p = next;
+            }
+            writer.EndVector();
+        }
+        else if (StartsWith(line, "G: ") && ParseImage(line, img))
+        {
+            writer.Image(img);
+        }
+        else if (ParseMarker(line, marker))
+        {
+            writer.Marker(marker);
+        }
+        else
+        {
+            writer.Text() << line << std::endl;
+        }
+    }
+    writer.Close();
+    return 0;
+}
+
+static void PutFixed32(std::ofstream & out, uint32_t v)
+{
+    std::string bytes;
+    BbvPutFixed(bytes, v, 4);
+    out.write(bytes.data(), bytes.size());
+}
+
+struct STREAM {
+    uint32_t id;
+    std::vector<std::string> slices;
+};
+
+static int WriteContainer(const char * name, int argc, char * argv[])
+{
+    std::vector<STREAM> streams;
+    for (int arg = 0; arg < argc; arg++)
+    {
+        const char * equal = strchr(argv[arg], '=');
+        if (!equal)
+            Usage();
+        STREAM stream;
+        std::string id(argv[arg], equal - argv[arg]);
+        stream.id = (id == "global") ? BBV_CONTAINER_GLOBAL :
+            strtoul(id.c_str(), NULL, 10);
+        std::ifstream in(equal + 1);
+        if (!in.is_open())
+        {
+            std::cerr << "bbvcheck: cannot open " << equal + 1 << std::endl;
+            return 1;
+        }
+        // slice N ends with its "T" line, the program end records follow
+        // in the slice after the last one
+        std::string line, slice;
+        while (std::getline(in, line))
+        {
+            slice += line + "\n";
+            if (StartsWith(line, "T"))
+            {
+                stream.slices.push_back(slice);
+                slice.clear();
+            }
+        }
+        stream.slices.push_back(slice);
+        streams.push_back(stream);
+    }
+
+    std::ofstream out(name, std::ios::binary);
+    if (!out.is_open())
+    {
+        std::cerr << "bbvcheck: cannot open " << name << std::endl;
+        return 1;
+    }
+    out.write(BBV_CONTAINER_MAGIC, sizeof(BBV_CONTAINER_MAGIC));
+    PutFixed32(out, BBV_CONTAINER_VERSION);
+    PutFixed32(out, 0);
+    for (uint32_t slice = 0; ; slice++)
+    {
+        bool more = false;
+        for (std::vector<STREAM>::const_iterator it = streams.begin();
+            it != streams.end(); it++)
+        {
+            if (slice >= it->slices.size())
+                continue;
+            more = true;
+            PutFixed32(out, it->id);
+            PutFixed32(out, slice);
+            PutFixed32(out, it->slices[slice].size());
+            out << it->slices[slice];
+        }
+        if (!more)
+            break;
+    }
+    return out.good() ? 0 : 1;
+}
+
+int main(int argc, char * argv[])
+{
+    if (argc == 5 && strcmp(argv[1], "bbb") == 0)
+        return WriteBinary(argv[2], atoi(argv[3]), argv[4]);
+    if (argc >= 4 && strcmp(argv[1], "bbc") == 0)
+        return WriteContainer(argv[2], argc - 3, argv + 3);
+    Usage();
+    return 1;
+}
@@ -18,12 +18,10 @@ END_LEGAL */
 #include "global_isimpoint_inst.H"
 
 
-VOID GLOBALBLOCK::ExecuteGlobal(THREADID tid, const GLOBALBLOCK* prev_block,
-   GLOBALISIMPOINT *gisimpoint)
+VOID GLOBALBLOCK::ExecuteGlobal(GLOBAL_THREAD_BLOCK_COUNTS * counts,
+   UINT32 slot, const GLOBALBLOCK* prev_block, GLOBALISIMPOINT *gisimpoint)
 {
-    ATOMIC::OPS::Increment<INT64>
-                (& _sliceBlockCountGlobal._count, 1); 
-    _sliceBlockCountThreads[tid]++;
+    ExecuteGlobal(counts, slot);
     if (IdGlobal() == 0)
       ASSERT(0,"IdGlobal()==0 in ExecuteGlobal() NYT "); 
 
@@ -36,37 +34,37 @@ VOID GLOBALBLOCK::ExecuteGlobal(THREADID tid, const GLOBALBLOCK* prev_block,
         // It should always have a count of one (1).
         UINT32 prevBlockId = prev_block ? prev_block->IdGlobal() : 0;
 
-        // Automagically add hash keys for this tid and prevBlockID 
-        // as needed and increment the counter.
-        ATOMIC::OPS::Increment<INT64>
-                (&(_blockCountMapGlobal[prevBlockId])._count, 1); 
-        ATOMIC::OPS::Increment<INT64>
-                (&(_blockCountMapThreads[tid][prevBlockId])._count, 1); 
+        // Automagically add hash keys for this prevBlockID as needed and
+        // increment the counter. Only this thread updates its map; the
+        // global counts are summed at program end.
+        counts->PrevBlockCounts(_index)[prevBlockId]++;
     }
 }
 
 VOID GLOBALBLOCK::EmitSliceEndGlobal(GLOBALPROFILE *gprofile)
 {
-    if (_sliceBlockCountGlobal._count == 0)
+    if (_sliceBlockCountGlobal == 0)
         return;
     
-    gprofile->BbFile << ":" << std::dec << IdGlobal() << ":" << std::dec 
-        << SliceInstructionCountGlobal() << " ";
-    ATOMIC::OPS::Increment<INT64>
-                (&_cumulativeBlockCountGlobal._count, 
-                _sliceBlockCountGlobal._count); 
-    _sliceBlockCountGlobal._count = 0;
+    gprofile->EmitVectorEntry(IdGlobal(), SliceInstructionCountGlobal());
+    RollSliceGlobal();
 }
 
-VOID GLOBALBLOCK::EmitSliceEndThread(THREADID tid, GLOBALPROFILE *profile)
+VOID GLOBALBLOCK::RollSliceGlobal()
 {
-    if (_sliceBlockCountThreads[tid] == 0)
+    _cumulativeBlockCountGlobal += _sliceBlockCountGlobal;
+    _sliceBlockCountGlobal = 0;
+}
+
+VOID GLOBALBLOCK::EmitSliceEndThread(GLOBAL_THREAD_BLOCK_COUNTS * counts,
+    GLOBALPROFILE *profile, UINT32 slot)
+{
+    INT64 sliceCount = counts->SliceCount(slot, _index);
+    if (sliceCount == 0)
         return;
 
-    profile->BbFile << ":" << std::dec << IdGlobal() << ":" << std::dec
-        << SliceInstructionCountThread(tid) << " ";
-    _cumulativeBlockCountThreads[tid] += _sliceBlockCountThreads[tid];
-    _sliceBlockCountThreads[tid] = 0;
+    profile->EmitVectorEntry(IdGlobal(), sliceCount * StaticInstructionCount());
+    RollSliceThread(counts, slot);
 }
 
 
@@ -76,61 +74,93 @@ VOID GLOBALBLOCK::EmitProgramEndGlobal(const BLOCK_KEY & key,
     // If this block has the start address of the slice we need to emit it
     // even if it was not executed.
     BOOL force_emit = gisimpoint->FoundInStartSlices(key.Start());
-    if (_cumulativeBlockCountGlobal._count == 0 && !force_emit)
+    if (_cumulativeBlockCountGlobal == 0 && !force_emit)
         return;
     
-    gprofile->BbFile << "Block id: " << std::dec << IdGlobal() << " " << std::hex 
+    gprofile->BbText() << "Block id: " << std::dec << IdGlobal() << " " << std::hex 
         << key.Start() << ":" << key.End() << std::dec
         << " static instructions: " << StaticInstructionCount()
-        << " block count: " << _cumulativeBlockCountGlobal._count
+        << " block count: " << _cumulativeBlockCountGlobal
         << " block size: " << key.Size();
+    if (gisimpoint->KnobStableIds)
+        gprofile->BbText() << " stable key: " << std::hex << _stableKey
+            << std::dec;
 
     // Output previous blocks and their counts only if enabled.
     // Example: previous-block counts: ( 3:1 5:13 7:3 )
     if (gisimpoint->KnobEmitPrevBlockCounts) {
-        gprofile->BbFile << " previous-block counts: ( ";
+        gprofile->BbText() << " previous-block counts: ( ";
+
+        // The global counts are the sum of the per-thread counts.
+        BLOCK_COUNT_MAP_GLOBAL blockCountMapGlobal;
+        const GLOBAL_THREAD_REGISTRY & threads = gisimpoint->Threads();
+        for (UINT32 t = 0; t < threads.Count(); t++) {
+            const GLOBAL_THREAD_BLOCK_COUNTS * counts =
+                gisimpoint->ThreadBlockCounts(threads.Tid(t));
+            const BLOCK_COUNT_MAP_GLOBAL * prevCounts =
+                counts ? counts->FindPrevBlockCounts(_index) : NULL;
+            if (!prevCounts)
+                continue;
+            for (BLOCK_COUNT_MAP_GLOBAL::const_iterator bci = 
+                  prevCounts->begin();
+                 bci != prevCounts->end();
+                 bci++) {
+                blockCountMapGlobal[bci->first] += bci->second;
+            }
+        }
 
         // output block-id:block-count pairs.
         for (BLOCK_COUNT_MAP_GLOBAL::const_iterator bci = 
-              _blockCountMapGlobal.begin();
-             bci != _blockCountMapGlobal.end();
+              blockCountMapGlobal.begin();
+             bci != blockCountMapGlobal.end();
              bci++) {
-            gprofile->BbFile << bci->first << ':' << bci->second._count << ' ';
+            gprofile->BbText() << bci->first << ':' << bci->second << ' ';
         }
-        gprofile->BbFile << ')';
+        gprofile->BbText() << ')';
     }
-    gprofile->BbFile << std::endl;
+    gprofile->BbText() << std::endl;
 }
 
 VOID GLOBALBLOCK::EmitProgramEndThread(const BLOCK_KEY & key, THREADID tid, 
     GLOBALPROFILE *gprofile, const GLOBALISIMPOINT *gisimpoint) const
 {
+    const GLOBAL_THREAD_BLOCK_COUNTS * counts =
+        gisimpoint->ThreadBlockCounts(tid);
+    INT64 cumulativeCount = counts ? counts->CumulativeCount(_index) : 0;
+
     // If this block has the start address of the slice we need to emit it
     // even if it was not executed.
     BOOL force_emit = gisimpoint->FoundInStartSlices(key.Start());
-    if (_cumulativeBlockCountThreads[tid] == 0 && !force_emit)
+    if (cumulativeCount == 0 && !force_emit)
         return;
     
-    gprofile->BbFile << "Block id: " << std::dec << IdGlobal() << " " << std::hex 
+    gprofile->BbText() << "Block id: " << std::dec << IdGlobal() << " " << std::hex 
         << key.Start() << ":" << key.End() << std::dec
         << " static instructions: " << StaticInstructionCount()
-        << " block count: " << _cumulativeBlockCountThreads[tid]
+        << " block count: " << cumulativeCount
         << " block size: " << key.Size();
+    if (gisimpoint->KnobStableIds)
+        gprofile->BbText() << " stable key: " << std::hex << _stableKey
+            << std::dec;
 
     // Output previous blocks and their counts only if enabled.
     // Example: previous-block counts: ( 3:1 5:13 7:3 )
     if (gisimpoint->KnobEmitPrevBlockCounts) {
-        gprofile->BbFile << " previous-block counts: ( ";
+        gprofile->BbText() << " previous-block counts: ( ";
 
+        const BLOCK_COUNT_MAP_GLOBAL * prevCounts =
+            counts ? counts->FindPrevBlockCounts(_index) : NULL;
         // output block-id:block-count pairs.
-        for (BLOCK_COUNT_MAP_GLOBAL::const_iterator bci = _blockCountMapThreads[tid].begin();
-             bci != _blockCountMapThreads[tid].end();
-             bci++) {
-            gprofile->BbFile << bci->first << ':' << bci->second._count << ' ';
+        if (prevCounts) {
+            for (BLOCK_COUNT_MAP_GLOBAL::const_iterator bci = prevCounts->begin();
+                 bci != prevCounts->end();
+                 bci++) {
+                gprofile->BbText() << bci->first << ':' << bci->second << ' ';
+            }
         }
-        gprofile->BbFile << ')';
+        gprofile->BbText() << ')';
     }
-    gprofile->BbFile << std::endl;
+    gprofile->BbText() << std::endl;
 }
 
 // Static knobs
@@ -140,10 +170,54 @@ KNOB<BOOL> GLOBALISIMPOINT::KnobGlobal (KNOB_MODE_WRITEONCE,
 KNOB<INT32> GLOBALISIMPOINT::KnobThreadProgress(KNOB_MODE_WRITEONCE,  
     "pintool:isimpoint",
     "thread_progress", "0", "N: number of threads: end global slice whenever any thread reaches 1/N th slice-size.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobSliceCredits(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "global_slice_credits", "0", "N: threads lease 1/N th slice-size instructions at a time from the global slice timer instead of updating it on every block. A slice boundary may be off by up to (number of threads) x (slice-size/N) instructions. 0: disabled.");
+KNOB<BOOL> GLOBALISIMPOINT::KnobVersions(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "global_versions", "0", "Instrument two versions of each trace: threads run a version that only counts blocks while the slice end is far away and switch to the version that checks for the slice end near it. Doubles the instrumentation work per trace and uses a tool register.");
+KNOB<BOOL> GLOBALISIMPOINT::KnobBinary(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_binary", "0", "With -global_profile, write binary .bbb profiles instead of .bb text (see bbv_format.H). Convert them with bbv2text.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobWriterQueue(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_writer_queue", "0", "With -global_profile, number of profile record buffers (one per profile per slice) queued for a background writer thread; a thread closing a slice waits when the queue is full. 0: write the profiles on the thread closing the slice.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobCompress(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_compress", "0", "With -global_profile, gzip level (1-9) for writing the .bb profiles as .bb.gz. 0: no compression.");
+KNOB<BOOL> GLOBALISIMPOINT::KnobContainer(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_container", "0", "With -global_profile, write the global and all the per-thread text profiles as chunks of one .global.bbc file (.bbc.gz with -bb_compress) instead of one file each. Split it with bbvdemux.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobProject(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_project", "0", "With -global_profile, also write the slice vectors normalized and randomly projected to N dimensions (.global.pbv, .T.<tid>.pbv) as regions.py --project_bbv does; simpoint.py uses 16. 0: disabled.");
+KNOB<UINT64> GLOBALISIMPOINT::KnobProjectSeed(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_project_seed", "1", "Seed of the -bb_project matrix; regions.py --projection_seed with the same seed projects identically.");
+KNOB<BOOL> GLOBALISIMPOINT::KnobProjectInline(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_project_inline", "0", "With -bb_project, accumulate the projected vectors per thread while the blocks execute instead of projecting the counted slice vectors: the .bb profiles then have no vectors and no slice markers. Not supported with -emit_prevblockcounts.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobCluster(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_cluster", "0", "With -bb_project, cluster the projected global slice vectors while profiling into at most N clusters (like SimPoint -maxK N) and write .global.simpoints, .global.weights and .global.labels in the SimPoint formats. 0: disabled.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobClusterCapacity(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_cluster_capacity", "256", "Number of micro-clusters -bb_cluster keeps to summarize the slices; bounds its memory and the work per slice.");
+KNOB<BOOL> GLOBALISIMPOINT::KnobDedup(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_dedup", "0", "With -global_profile, write a slice whose vector equals the one of an earlier slice of the same profile as a \"T=<n>\" back-reference to slice n (0 based) instead of repeating the \"T\" line.");
+KNOB<BOOL> GLOBALISIMPOINT::KnobStableIds(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "bb_stable_ids", "0", "With -global_profile, add to every \"Block id:\" record a stable key computed from the image (build-id, or path without one) and the block offsets in it, and list the images as \"Image key:\" records. Profiles of separate runs can then be merged into one block id space.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobLdvBufferPages(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "ldv_buffer_pages", "0", "With -global_profile and -ldv_type, record the memory operand addresses of each thread in a Pin trace buffer of this many pages and update its reuse distances when the buffer fills. The per-slice LDVs are then approximate: addresses still buffered at a slice end count in the thread's next slice. 0: update on every memory operand, exact per slice.");
+KNOB<UINT32> GLOBALISIMPOINT::KnobLdvSample(KNOB_MODE_WRITEONCE,  
+    "pintool:isimpoint",
+    "ldv_sample", "0", "With -global_profile and -ldv_type, measure the reuse distances of about 1 in N cache lines, chosen by an address hash (SHARDS fixed-rate sampling), and scale the distances and counts by N. Each .ldv slice is preceded by a comment with the sampled accesses and the estimated relative error. 0 or 1: all the lines.");
 KNOB<UINT32> GLOBALISIMPOINT::KnobSpinStartSSC(KNOB_MODE_WRITEONCE,  
     "pintool:isimpoint",
     "spin_start_SSC", "0", "SSC marker (0x...) for the start of spin loop to be skipped ");
 KNOB<UINT32> GLOBALISIMPOINT::KnobSpinEndSSC(KNOB_MODE_WRITEONCE,  
     "pintool:isimpoint",
     "spin_end_SSC", "0", "SSC marker (0x...) for the end of spin loop to be skipped ");
-PIN_RWMUTEX GLOBALISIMPOINT::_StopTheWorldLock;
@@ -0,0 +1,64 @@
+#!/bin/bash
+# Copyright (C) 2022 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Time and size of the global profiler output for each -bb_compress level:
+# the same whole-program pinball (e.g. one of the dot-product tests) is
+# profiled once with text output and once per gzip level.
+#
+# Usage: run.compress-bench.sh <pinball-basename> [slice-size]
+#   SDE_BUILD_KIT : SDE kit with the GlobalLoopPoint tools installed
+#   TOOL          : pintool to use (default: $SDE_BUILD_KIT/intel64/looppoint.so)
+#   LEVELS        : gzip levels to try (default: "1 6 9")
+
+if [[  -z $SDE_BUILD_KIT ]]; then
+    echo "SDE_BUILD_KIT not defined"
+    exit 1
+fi
+
+if [[ $# -lt 1 ]]; then
+    echo "Usage: $0 <pinball-basename> [slice-size]"
+    exit 1
+fi
+
+PINBALL=$1
+SLICE_SIZE=${2:-100000000}
+TOOL=${TOOL:-$SDE_BUILD_KIT/intel64/looppoint.so}
+LEVELS=${LEVELS:-"1 6 9"}
+OUTDIR=compress-bench.$$
+mkdir -p $OUTDIR
+
+# run <name> <tool knobs>: prints the elapsed seconds
+run()
+{
+    name=$1
+    shift
+    start=`date +%s.%N`
+    $SDE_BUILD_KIT/sde64 -t64 $TOOL -replay -replay:basename $PINBALL \
+        -replay:addr_trans -bbprofile -global_profile \
+        -slice_size $SLICE_SIZE -o $OUTDIR/$name "$@" \
+        -- $SDE_BUILD_KIT/intel64/nullapp > $OUTDIR/$name.log 2>&1
+    end=`date +%s.%N`
+    echo "$end - $start" | bc
+}
+
+# total bytes of the .bb files of a run
+size()
+{
+    cat $OUTDIR/$1.global.bb* $OUTDIR/$1.T.*.bb* 2>/dev/null | wc -c
+}
+
+printf "%-10s %10s %14s %8s\n" output seconds bytes ratio
+t=`run text`
+text_size=`size text`
+printf "%-10s %10.2f %14d %8s\n" text $t $text_size 1.00
+for level in $LEVELS; do
+    t=`run gz$level -bb_compress $level`
+    n=`size gz$level`
+    if ! zcat $OUTDIR/gz$level.global.bb.gz | cmp -s - $OUTDIR/text.global.bb
+    then
+        echo "gz$level: output differs from the text profile"
+    fi
+    ratio=`echo "scale=2; $text_size / $n" | bc`
+    printf "%-10s %10.2f %14d %8s\n" gz$level $t $n $ratio
+done
@@ -0,0 +1,82 @@
+#!/bin/bash
+# Copyright (C) 2022 Intel Corporation
+# SPDX-License-Identifier: BSD-3-Clause
+#
+# Per-BBL cost of the global profiler's counting routine variants
+# (GLOBALISIMPOINT::CountBlock_IfGlobal<>): the same whole-program pinball
+# is replayed once without profiling and once per knob combination, and the
+# extra time is divided by the number of dynamic blocks counted.
+# -global_versions is turned off so that every block runs the
+# CountBlock_IfGlobal<> instantiation of its variant.
+#
+# Usage: run.count-variants-bench.sh <pinball-basename> [slice-size]
+#   SDE_BUILD_KIT : SDE kit with the GlobalLoopPoint tools installed
+#   TOOL          : pintool to use (default: $SDE_BUILD_KIT/intel64/looppoint.so)
+
+if [[  -z $SDE_BUILD_KIT ]]; then
+    echo "SDE_BUILD_KIT not defined"
+    exit 1
+fi
+
+if [[ $# -lt 1 ]]; then
+    echo "Usage: $0 <pinball-basename> [slice-size]"
+    exit 1
+fi
+
+PINBALL=$1
+SLICE_SIZE=${2:-100000000}
+TOOL=${TOOL:-$SDE_BUILD_KIT/intel64/looppoint.so}
+OUTDIR=count-variants-bench.$$
+mkdir -p $OUTDIR
+
+# run <name> <tool knobs>: prints the elapsed seconds
+run()
+{
+    name=$1
+    shift
+    start=`date +%s.%N`
+    $SDE_BUILD_KIT/sde64 -t64 $TOOL -replay -replay:basename $PINBALL \
+        -replay:addr_trans "$@" -- $SDE_BUILD_KIT/intel64/nullapp \
+        > $OUTDIR/$name.log 2>&1
+    end=`date +%s.%N`
+    echo "$end - $start" | bc
+}
+
+# dynamic blocks counted: sum of the "block count:" fields of the global
+# profile
+blocks()
+{
+    awk '/^Block id:/ { for (i = 1; i < NF; i++)
+        if ($i == "count:" && $(i-1) == "block") n += $(i+1) }
+        END { print n + 0 }' $OUTDIR/$1.global.bb 2>/dev/null
+}
+
+base=`run noprofile`
+echo "no profiling: $base s"
+
+PROFILE="-bbprofile -global_profile -global_versions 0 -slice_size $SLICE_SIZE"
+printf "%-20s %10s %14s %10s\n" variant seconds blocks ns/block
+while read name knobs; do
+    t=`run $name $PROFILE -o $OUTDIR/$name $knobs`
+    n=`blocks $name`
+    # The pinball replays the same blocks in every run. The prevblock
+    # variant stops at the "NYT" assertion of EmitProgramEndGlobal() after
+    # the last slice and writes no "Block id:" records, so it reuses the
+    # count of the first variant.
+    if [[ $n -eq 0 && -n $first ]]; then
+        n=$first
+    fi
+    first=${first:-$n}
+    if [[ $n -eq 0 ]]; then
+        echo "$name: no blocks counted, see $OUTDIR/$name.log"
+        continue
+    fi
+    ns=`echo "scale=2; ($t - $base) * 1000000000 / $n" | bc`
+    printf "%-20s %10.2f %14d %10s\n" $name $t $n $ns
+done <<EOF
+global
+thread_progress -thread_progress 8
+credits -global_slice_credits 64
+spin -spin_start_SSC 0x1 -spin_end_SSC 0x2
+prevblock -emit_prevblockcounts
+EOF
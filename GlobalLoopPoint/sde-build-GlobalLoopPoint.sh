@@ -41,6 +41,13 @@ make TARGET=intel64 CFLAGS=$CFLAGS
 make clean TARGET=intel64 
 cd -
 
+# offline tools for -bb_binary profiles
+cd ./BBVTools
+make clean
+make install
+make clean
+cd -
+
 cd Drivers/BarrierPoint/
 make clean TARGET=ia32 
 make build TARGET=ia32 CFLAGS=$CFLAGS
@@ -1655,6 +1655,41 @@ def project_bbv(parser, group):
         "a random projection matrix.  Normalizes resulting vectors.  Must use option --bbv_file.")
 
 
+def projection_seed(parser, group):
+    method = GetMethod(parser, group)
+    method(
+        "--projection_seed",
+        dest="projection_seed",
+        type=int,
+        default=None,
+        help="Generate the random projection matrix from this seed, the way "
+        "the global profiler does with '-bb_project N -bb_project_seed SEED'.  "
+        "The projected vectors are then the same for every run and the same as "
+        "the profiler's .pbv file.  Default: a new random matrix every run.")
+
+
+def proj_bbv_file(parser, group):
+    method = GetMethod(parser, group)
+    method(
+        "--proj_bbv_file",
+        dest="proj_bbv_file",
+        default='',
+        help="Use this projected, normalized BBV file written by the global "
+        "profiler with '-bb_project 16' (<basename>.global.pbv) instead of "
+        "projecting the BBV file.  Only used with --ldv.")
+
+
+def cluster_files(parser, group):
+    method = GetMethod(parser, group)
+    method(
+        "--cluster_files",
+        dest="cluster_files",
+        default='',
+        help="Use the clusters found by the global profiler with '-bb_cluster' "
+        "(<basename>.global.simpoints, .weights and .labels): give the "
+        "basename up to and including '.global'.  Simpoint is not run.")
+
+
 def weight_ldv(parser, group):
     method = GetMethod(parser, group)
     method(
@@ -195,6 +195,14 @@ def OpenWeightsFile(wt_file, type_str):
     return fp
 
 
+# Per file, the offsets of the 'T' lines of the slices read so far by
+# GetSlice(): (offset of the line, offset of the full vector).  Used to
+# expand the "T=<n>" back-references of the profiles written with
+# -bb_dedup, which repeat the vector of slice n (0 based).
+#
+slice_offsets = {}
+
+
 def GetSlice(fp):
     """
     Get the frequency vector for one slice (i.e. line in the FV file).
@@ -210,6 +218,7 @@ def GetSlice(fp):
     """
 
     fv = []
+    pos = fp.tell()
     line = ensure_string(fp.readline())
     while not line.startswith('T') and line:
         # print 'Skipping line: ' + line
@@ -221,9 +230,23 @@ def GetSlice(fp):
         if line.startswith('Block id:'):
             fp.seek(0 - len(line), os.SEEK_CUR)
             return []
+        pos = fp.tell()
         line = ensure_string(fp.readline())
     if line == '': return []
 
+    offsets = slice_offsets.setdefault(fp, [])
+    vector_pos = pos
+    if line.startswith('T='):
+        # Back-reference: read the vector of the earlier slice.
+        #
+        vector_pos = offsets[int(line[2:])][1]
+        next_pos = fp.tell()
+        fp.seek(vector_pos)
+        line = ensure_string(fp.readline())
+        fp.seek(next_pos)
+    if not offsets or pos > offsets[-1][0]:
+        offsets.append((pos, vector_pos))
+
     # If vector only contains the char 'T', then assume it's a slice which
     # contains no data.
     #
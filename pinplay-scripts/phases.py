@@ -772,6 +772,12 @@ class Phases(object):
             path_bb_file = os.path.join(data_dir, basename) + '.T.0.bb'
             triggering_tid = 0
 
+        # BB files written with '-bb_compress' have the suffix '.gz'.
+        #
+        if not os.path.isfile(path_bb_file) and \
+           os.path.isfile(path_bb_file + '.gz'):
+            path_bb_file += '.gz'
+
         bb_file = os.path.basename(path_bb_file)  # Remove directory name
         sim_out_file = basename + '_simpoint_out.txt'
         sim_in_file = 'simpoint_in.txt'
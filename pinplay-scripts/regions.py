@@ -253,6 +253,7 @@ def GetOptions():
     combine(parser, action_group)
     cmd_options.csv_region(parser, action_group)
     cmd_options.project_bbv(parser, action_group)
+    cmd_options.projection_seed(parser, '')
     cmd_options.weight_ldv(parser, action_group)
 
     parser.add_option_group(action_group)
@@ -342,6 +343,14 @@ def GetOptions():
     return (options, fp_bbv, fp_ldv, fp_simp, fp_weight)
 
 
+# Per file, the offsets of the 'T' lines of the slices read so far by
+# GetSlice(): (offset of the line, offset of the full vector).  Used to
+# expand the "T=<n>" back-references of the profiles written with
+# -bb_dedup, which repeat the vector of slice n (0 based).
+#
+slice_offsets = {}
+
+
 def GetSlice(fp):
     """
     Get the frequency vector for one slice (i.e. line in the FV file).
@@ -357,6 +366,7 @@ def GetSlice(fp):
     """
 
     fv = []
+    pos = fp.tell()
     line = ensure_string(fp.readline())
     while not line.startswith('T') and line:
         # print 'Skipping line: ' + line
@@ -368,9 +378,23 @@ def GetSlice(fp):
         if line.startswith('Block id:'):
             fp.seek(0 - len(line), os.SEEK_CUR)
             return []
+        pos = fp.tell()
         line = ensure_string(fp.readline())
     if line == '': return []
 
+    offsets = slice_offsets.setdefault(fp, [])
+    vector_pos = pos
+    if line.startswith('T='):
+        # Back-reference: read the vector of the earlier slice.
+        #
+        vector_pos = offsets[int(line[2:])][1]
+        next_pos = fp.tell()
+        fp.seek(vector_pos)
+        line = ensure_string(fp.readline())
+        fp.seek(next_pos)
+    if not offsets or pos > offsets[-1][0]:
+        offsets.append((pos, vector_pos))
+
     # If vector only contains the char 'T', then assume it's a slice which
     # contains no data.
     #
@@ -842,11 +866,42 @@ def GenRegionCSV(options, fp_bbv, fp_simp, fp_weight):
 ############################################################################
 
 
-def GetDimRandomVector(proj_matrix, proj_dim, dim):
+MASK64 = (1 << 64) - 1
+
+
+def SplitMix64(x):
+    """
+    SplitMix64 hash of a 64-bit value, as in GLOBAL_PROJECTION of the global
+    profiler.
+
+    @return 64-bit hash
+    """
+
+    x = (x + 0x9e3779b97f4a7c15) & MASK64
+    x = ((x ^ (x >> 30)) * 0xbf58476d1ce4e5b9) & MASK64
+    x = ((x ^ (x >> 27)) * 0x94d049bb133111eb) & MASK64
+    return x ^ (x >> 31)
+
+
+def SeededProjValue(seed, dim, index):
+    """
+    Value of the seeded projection matrix for dimension 'dim' of the FV and
+    'index' of the projected vector.  Same as GLOBAL_PROJECTION::Value() in
+    the global profiler, so both generate the same matrix for a seed.
+
+    @return float between -1 and 1
+    """
+
+    h = SplitMix64((SplitMix64((seed & MASK64) ^ SplitMix64(dim)) + index) & MASK64)
+    return -1.0 + 2.0 * ((h >> 11) * (1.0 / 9007199254740992.0))
+
+
+def GetDimRandomVector(proj_matrix, proj_dim, dim, seed=None):
     """
     Get the random vector for dimension 'dim'.  If it's already in 'proj_matrix',
     then just return it.  Otherwise, generate a new random vector of length
-    'proj_dim' with values between -1 and 1.
+    'proj_dim' with values between -1 and 1.  If 'seed' is given, the values
+    are derived from the seed and 'dim' instead of the default random source.
 
     @return list of length 'dim' which contains vector of random values
     """
@@ -857,6 +912,10 @@ def GetDimRandomVector(proj_matrix, proj_dim, dim):
         vector = proj_matrix.get(dim)
     else:
         # print 'Generating random vector: %4d' % dim
+        if seed is not None:
+            vector = [SeededProjValue(seed, dim, index) for index in range(proj_dim)]
+            proj_matrix[dim] = vector
+            return vector
         random.seed()  # Use default source for seed
         vector = []
         index = 0
@@ -881,7 +940,7 @@ def PrintProjMatrix(matrix):
         print()
 
 
-def ProjectFVFile(fp, proj_dim=15):
+def ProjectFVFile(fp, proj_dim=15, seed=None):
     """
     Read all the slices in a frequency vector file, normalize them and use a
     random projection matrix to project them onto a result matrix with dimensions:
@@ -948,7 +1007,7 @@ def ProjectFVFile(fp, proj_dim=15):
             # Get the random vector for the dimension 'dim' and project the values for
             # 'dim' into the result
             #
-            proj_vector = GetDimRandomVector(proj_matrix, proj_dim, dim)
+            proj_vector = GetDimRandomVector(proj_matrix, proj_dim, dim, seed)
             index = 0
             while index < proj_dim:
                 result_vector[index] += count * proj_vector[index]
@@ -1201,7 +1260,8 @@ if options.combine and options.combine >= 0.0:
 elif options.csv_region:
     GenRegionCSV(options, fp_bbv, fp_simp, fp_weight)
 elif options.project_bbv:
-    result_matrix = ProjectFVFile(fp_bbv, proj_dim=int(options.dimensions))
+    result_matrix = ProjectFVFile(fp_bbv, proj_dim=int(options.dimensions),
+                                  seed=options.projection_seed)
     PrintVectorFile(result_matrix)
 elif options.weight_ldv:
     result_matrix = GetWeightedLDV(fp_ldv, num_dim=int(options.dimensions))
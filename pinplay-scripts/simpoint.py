@@ -98,6 +98,9 @@ class SimPoint(object):
         cmd_options.pccount_regions(parser, '')
         cmd_options.num_cores(parser, '')
         cmd_options.simpoint_options(parser, '')
+        cmd_options.projection_seed(parser, '')
+        cmd_options.proj_bbv_file(parser, '')
+        cmd_options.cluster_files(parser, '')
 
         (options, args) = parser.parse_args()
 
@@ -168,6 +171,19 @@ class SimPoint(object):
         @return result of command to generate projected file
         """
 
+        # Use the vectors projected by the profiler if given.
+        #
+        if options.proj_bbv_file:
+            try:
+                shutil.copy(options.proj_bbv_file, self.proj_bbv_file)
+            except (IOError, OSError):
+                msg.PrintMsg('ERROR: Failed to copy projected BBV file:\n'
+                             '   ' + options.proj_bbv_file)
+                return -1
+            msg.PrintMsg('   Output file: %s (copied from %s)\n' %
+                         (self.proj_bbv_file, options.proj_bbv_file))
+            return 0
+
         # Format the command and run it.
         #
         # import pdb;  pdb.set_trace()
@@ -195,6 +211,8 @@ class SimPoint(object):
         cmd += ' --bbv_file'
         cmd += ' ' + self.generic_bbv_name
         cmd += ' --dimensions 16'
+        if options.projection_seed is not None:
+            cmd += ' --projection_seed ' + str(options.projection_seed)
 
         # msg.PrintMsg('')
         # print 'cmd: ' + cmd
@@ -308,6 +326,28 @@ class SimPoint(object):
 
         return result
 
+    def ExpandSliceRefs(self):
+        """
+        Simpoint reads the BBV file itself, so replace the "T=<n>"
+        back-references of a profile written with '-bb_dedup' by the
+        vector of slice n.
+        """
+
+        with open(self.generic_bbv_name) as f_in:
+            if not any(line.startswith('T=') for line in f_in):
+                return
+        expanded = self.generic_bbv_name + '.expanded'
+        vectors = []
+        with open(self.generic_bbv_name) as f_in:
+            with open(expanded, 'w') as f_out:
+                for line in f_in:
+                    if line.startswith('T='):
+                        line = vectors[int(line[2:])]
+                    if line.startswith('T'):
+                        vectors.append(line)
+                    f_out.write(line)
+        os.rename(expanded, self.generic_bbv_name)
+
     def RunSimpoint(self, options):
         """
         Format and execute the command to run Simpoint.
@@ -319,6 +359,20 @@ class SimPoint(object):
 
         import subprocess
 
+        if options.cluster_files:
+            # Clustered by the profiler: use its files as Simpoint's.
+            for ext in ['simpoints', 'weights', 'labels']:
+                cluster_file = options.cluster_files + '.' + ext
+                try:
+                    shutil.copy(cluster_file, './t.' + ext)
+                except (IOError, OSError):
+                    msg.PrintMsg('ERROR: Failed to copy cluster file:\n'
+                                 '   ' + cluster_file)
+                    return -1
+                msg.PrintMsg('   Output file: t.%s (copied from %s)' %
+                             (ext, cluster_file))
+            return 0
+
         # Output file for simpoint
         #
         output_file = 'simpoint.out'
@@ -462,7 +516,7 @@ class SimPoint(object):
         # Make sure required utilities exist and are executable.
         #
         # import pdb;  pdb.set_trace()
-        if util.Which(self.simpoint_bin) == None:
+        if util.Which(self.simpoint_bin) == None and not options.cluster_files:
             msg.PrintAndExit('simpoint binary not in path.\n'
                              'Add directory where it exists to your path.')
         if util.Which(self.csv_bin) == None:
@@ -479,7 +533,15 @@ class SimPoint(object):
         #
         if os.path.isfile(self.generic_bbv_name):
             os.remove(self.generic_bbv_name)
-        shutil.copy(options.bbv_file, self.generic_bbv_name)
+        if options.bbv_file.endswith('.gz'):
+            # Written with '-bb_compress'.
+            import gzip
+            with gzip.open(options.bbv_file, 'rb') as f_in:
+                with open(self.generic_bbv_name, 'wb') as f_out:
+                    shutil.copyfileobj(f_in, f_out)
+        else:
+            shutil.copy(options.bbv_file, self.generic_bbv_name)
+        self.ExpandSliceRefs()
         ldv_file = options.bbv_file.replace('.bb', '.ldv')
         if os.path.isfile(ldv_file):
             if os.path.isfile(self.generic_ldv_name):
@@ -964,7 +964,12 @@ def FindStringRaw(filename, search_string):
     val = None
     if os.path.isfile(filename):
         try:
-            f = open(filename, 'r')
+            # BB files written with '-bb_compress' are gzip streams.
+            if filename.endswith('.gz'):
+                import gzip
+                f = gzip.open(filename, 'rt')
+            else:
+                f = open(filename, 'r')
         except IOError:
             msg.PrintAndExit(
                 'function util.FindStringRaw(), can\'t open file: ' + filename)